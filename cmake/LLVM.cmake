@@ -12,7 +12,8 @@ message(STATUS "Using LLVMConfig.cmake in: ${LLVM_DIR}")
 set(LLVM_LIBRARIES LLVMCore
     LLVMSupport
     LLVMPasses
-    LLVMIRReader)
+    LLVMIRReader
+    LLVMBitWriter)
 
 # Split the definitions properly (https://weliveindetail.github.io/blog/post/2017/07/17/notes-setup.html)
 separate_arguments(LLVM_DEFINITIONS)
@@ -1,27 +1,104 @@
 #pragma once
 
+#include <llvm/ADT/ArrayRef.h>
 #include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/GVMaterializer.h>
 #include <llvm/IR/Function.h>
 #include <llvm/IR/Module.h>
+#include <llvm/IR/ValueMap.h>
 
 #include <Zydis/Zydis.h>
 
+#include <array>
+#include <functional>
+#include <memory>
+#include <set>
+
 class UILifter {
 public:
 
-  static UILifter &Get(llvm::Module &Module, bool Is64 = true, bool Debug = false) {
-    static UILifter instance(Module, Is64, Debug);
+  static UILifter &Get(llvm::Module &Module, bool Is64 = true, bool Debug = false, bool Lazy = false) {
+    static UILifter instance(Module, Is64, Debug, Lazy);
     return instance;
   }
 
-  llvm::Function *Lift(const std::vector<ZyanU8> &bytes, size_t address = 0) const;
+  // Independent instance, used when several lifters must live in different contexts
+  static std::unique_ptr<UILifter> Create(llvm::Module &Module, bool Is64 = true, bool Debug = false, bool Lazy = false) {
+    return std::unique_ptr<UILifter>(new UILifter(Module, Is64, Debug, Lazy));
+  }
+
+  // Check if the bytes can be decoded, Lift aborts on undecodable bytes
+  bool CanLift(const std::vector<ZyanU8> &bytes) const;
+
+  struct InstructionInfo {
+    ZydisMnemonic mnemonic = ZYDIS_MNEMONIC_INVALID;
+    std::string form;             // explicit operands form (e.g. "r64,m64" or "xmm128,i8")
+    std::set<ZydisRegister> errw; // explicitly read+written GPRs
+    std::set<ZydisRegister> erw;  // explicitly written GPRs
+    std::set<ZydisRegister> err;  // explicitly read GPRs
+    std::set<ZydisRegister> irrw; // implicitly read+written GPRs
+    std::set<ZydisRegister> irw;  // implicitly written GPRs
+    std::set<ZydisRegister> irr;  // implicitly read GPRs
+    std::vector<std::string> icf; // implicitly clobbered flags
+  };
+
+  // Retrieve the registers and clobbers classification used by Lift, false if the bytes can't be decoded
+  bool Classify(const std::vector<ZyanU8> &bytes, InstructionInfo &info) const;
+
+  // In lazy mode only the declaration is generated, the body is emitted on materialization.
+  // The module materializer is owned by the module and refers to this lifter, so a lazy lifter
+  // must outlive its module, and the module can't already have a foreign materializer (e.g. a
+  // module loaded with getLazyIRFileModule)
+  llvm::Function *Lift(const std::vector<ZyanU8> &bytes, size_t address = 0);
+
+  struct LiftEntry {
+    size_t address = 0;
+    size_t length = 0;
+    uint64_t hash = 0;
+    llvm::Function *function = nullptr;
+  };
+
+  // Lifted function registered at the given non-zero instruction address, nullptr if none.
+  // The returned entries point into the index: any later Lift or deletion of an indexed function invalidates them
+  const LiftEntry *Lookup(size_t address) const;
+
+  // Lifted functions registered in the [begin, end) address interval, sorted by address, invalidated like Lookup(address)
+  llvm::ArrayRef<LiftEntry> Lookup(size_t begin, size_t end) const;
+
+  std::string GetSymbolName(ZydisMnemonic mnemonic, size_t address) const;
+
+  struct ScanEntry {
+    size_t address = 0;
+    ZyanU8 length = 0;
+    ZydisMnemonic mnemonic = ZYDIS_MNEMONIC_INVALID;
+  };
+
+  // The filter receives instructions decoded in minimal mode (no operands information),
+  // it is called concurrently by the scanning threads so it must be thread-safe and must not throw
+  using ScanFilter = std::function<bool(const ZydisDecodedInstruction &)>;
+
+  // Linear sweep of the buffer returning the instructions selected by the filter, split across threads,
+  // the result is the same as a single threaded sweep
+  std::vector<ScanEntry> Scan(const ZyanU8 *buffer, size_t size, size_t address, const ScanFilter &filter, size_t threads = 0) const;
+
+  void Materialize(llvm::Function *Function);
+
+  void MaterializeAll();
 
   UILifter(UILifter const &)       = delete;
   void operator=(UILifter const &) = delete;
 
 private:
 
-  UILifter(llvm::Module &Module, bool Is64, bool IsDebug);
+  UILifter(llvm::Module &Module, bool Is64, bool IsDebug, bool IsLazy);
+
+  std::vector<llvm::StructType *> getIdentifiedStructTypes() const;
+
+  InstructionInfo classify(const ZydisDecodedInstruction &instruction) const;
+
+  void liftBody(llvm::Function *InlineAsmFunction, const ZydisDecodedInstruction &instruction, size_t address) const;
+
+  uint64_t getEncodingHash(const ZyanU8 *bytes, size_t length) const;
 
   std::string getDisassemblyString(const ZydisDecodedInstruction &instruction, size_t address = 0) const;
 
@@ -31,8 +108,42 @@ private:
 
   bool mIs64 = false;
   bool mDebug = false;
+  bool mLazy = false;
+
+  struct PendingLift {
+    std::array<ZyanU8, ZYDIS_MAX_INSTRUCTION_LENGTH> bytes{};
+    ZyanU8 length = 0;
+    size_t address = 0;
+  };
+
+  // The entries are dropped when the pending functions are deleted
+  llvm::ValueMap<llvm::Function *, PendingLift> mPending;
+
+  // Materializer installed in the module, cleared when the module destroys it
+  llvm::GVMaterializer *mMaterializer = nullptr;
+
+  friend class UIMaterializer;
+
+  // Address index of the lifted functions, kept sorted by address
+  std::vector<LiftEntry> mIndex;
+
+  // Remove the entry of a deleted function from the address index
+  void unindex(llvm::Function *Function);
+
+  struct IndexConfig : llvm::ValueMapConfig<llvm::Function *> {
+    enum { FollowRAUW = false };
+    using ExtraData = UILifter *;
+    static void onDelete(UILifter *Lifter, llvm::Function *Function) { Lifter->unindex(Function); }
+  };
+
+  // Address of each indexed function, tracking their deletion
+  llvm::ValueMap<llvm::Function *, size_t, IndexConfig> mIndexed{ this };
+
+  // Minimum number of bytes swept by each scanning thread
+  static constexpr size_t MinScanChunkSize = 0x10000;
 
   ZydisDecoder mDecoder;
+  ZydisDecoder mScanDecoder;
   ZydisMachineMode mMode;
   ZydisAddressWidth mWidth;
 
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <main.h>
+
+#include <llvm/Support/raw_ostream.h>
+
+#include <map>
+#include <string>
+#include <utility>
+
+// Histogram of the instructions going through the inline assembly path,
+// grouped by mnemonic and explicit operands form.
+
+class UIProfiler {
+public:
+
+  explicit UIProfiler(UILifter &Lifter) : mLifter(Lifter) {}
+
+  // Classify and measure a single instruction, false if the bytes can't be decoded
+  bool Add(const std::vector<ZyanU8> &bytes);
+
+  // Scan the buffer and profile the instructions selected by the filter, returns the number of profiled instructions
+  size_t AddBuffer(const ZyanU8 *buffer, size_t size, size_t address, const UILifter::ScanFilter &filter);
+
+  // Write the histogram as JSON, the most frequent stubs first
+  void Write(llvm::raw_ostream &OS) const;
+
+private:
+
+  struct Entry {
+    size_t count = 0;
+    size_t errw = 0;
+    size_t erw = 0;
+    size_t err = 0;
+    size_t irrw = 0;
+    size_t irw = 0;
+    size_t irr = 0;
+    std::map<std::string, size_t> clobbers;
+    size_t irTotal = 0;
+    size_t irMin = 0;
+    size_t irMax = 0;
+  };
+
+  UILifter &mLifter;
+
+  size_t mCount = 0;
+  std::map<std::pair<std::string, std::string>, Entry> mEntries;
+
+  // Emitted IR instructions count of each stub shape, the measured stubs aren't kept in the module
+  std::map<std::string, size_t> mSizes;
+
+};
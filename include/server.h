@@ -0,0 +1,116 @@
+#pragma once
+
+#include <main.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+// Lift server listening on a Unix domain socket, the integers are little endian:
+//   Request:  | u8 format | u64 address | u8 size | u8 bytes[size] |
+//   Response: | u8 status | u32 size | u8 payload[size] |
+// The requests are pipelined, each connection receives the responses in the requests order.
+// The payload is the bitcode or the textual IR of a module holding the lifted function,
+// or the error message when the status is a failure.
+// A single thread multiplexes the connections with non-blocking I/O, reading while the
+// responses are pending, and dispatches the batches of complete requests to the workers.
+// A connection isn't read anymore while its pending requests and responses exceed MaxConnectionBuffer.
+
+class UIServer {
+public:
+
+  enum Format : ZyanU8 {
+    FORMAT_BITCODE = 0,
+    FORMAT_TEXT = 1
+  };
+
+  enum Status : ZyanU8 {
+    STATUS_SUCCESS = 0,
+    STATUS_FAILURE = 1
+  };
+
+  static constexpr size_t RequestHeaderSize = 10;
+  static constexpr size_t ResponseHeaderSize = 5;
+
+  UIServer(const std::string &Path, size_t Workers = 0, bool Is64 = true);
+
+  ~UIServer();
+
+  // Accept and serve the clients until Stop is called or the polling fails, an existing file
+  // at the path is only replaced if it's a socket
+  int Run();
+
+  // Make Run return once the dispatched batches are served, can be called from any thread
+  void Stop();
+
+  UIServer(UIServer const &)       = delete;
+  void operator=(UIServer const &) = delete;
+
+private:
+
+  // Maximum number of requests of a connection served by a single batch
+  static constexpr size_t MaxBatchRequests = 256;
+
+  // Number of lifts after which a worker recreates its LLVM context, bounding the types it accumulates
+  static constexpr size_t MaxWorkerLifts = 0x10000;
+
+  // Maximum number of responses kept by the cache shared by the workers
+  static constexpr size_t MaxCachedResponses = 0x1000;
+
+  // Size of the pending requests and responses above which a connection isn't read nor dispatched
+  static constexpr size_t MaxConnectionBuffer = 0x400000;
+
+  struct Connection {
+    std::vector<ZyanU8> input;
+    std::string output;
+    bool busy = false;   // a batch is being served by a worker
+    bool closed = false; // no more requests will be read
+    bool broken = false; // the responses can't be sent anymore
+    bool full() const { return input.size() + output.size() >= MaxConnectionBuffer; }
+  };
+
+  struct Batch {
+    int socket = -1;
+    std::vector<ZyanU8> requests;
+    std::string responses;
+  };
+
+  void serveWorker();
+
+  // Serve a single request, returns true if the instruction has been lifted
+  bool serveRequest(const ZyanU8 *Request, UILifter &Lifter, llvm::Module &Module, std::string &Response);
+
+  void readClient(int Socket, Connection &Client) const;
+
+  void writeClient(int Socket, Connection &Client) const;
+
+  void dispatchClient(int Socket, Connection &Client);
+
+  bool findResponse(const std::string &Key, std::string &Response);
+
+  void storeResponse(const std::string &Key, const std::string &Response);
+
+  std::string mPath;
+  size_t mWorkers = 0;
+  bool mIs64 = false;
+
+  // Pipe used by the workers and Stop to wake up the connections thread
+  int mWakeup[2] = { -1, -1 };
+  std::atomic<bool> mStopping{ false };
+
+  std::mutex mMutex;
+  std::condition_variable mCondition;
+  std::deque<Batch> mPending;
+  std::deque<Batch> mServed;
+  bool mStop = false;
+
+  // Least recently used responses, keyed by the request
+  std::mutex mCacheMutex;
+  std::list<std::pair<std::string, std::string>> mCache;
+  std::unordered_map<std::string, std::list<std::pair<std::string, std::string>>::iterator> mCacheIndex;
+
+};
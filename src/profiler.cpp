@@ -0,0 +1,106 @@
+#include <profiler.h>
+
+#include <llvm/Support/JSON.h>
+
+#include <algorithm>
+
+bool UIProfiler::Add(const std::vector<ZyanU8> &bytes) {
+
+  // Classify the instruction like Lift does
+
+  UILifter::InstructionInfo info;
+  if (!mLifter.Classify(bytes, info))
+    return false;
+
+  // The emitted stub size only depends on the form and on the registers and clobbers counts
+
+  std::string shape = std::string(ZydisMnemonicGetString(info.mnemonic)) + " " + info.form;
+  for (const auto count : { info.errw.size(), info.erw.size(), info.err.size(), info.irrw.size(), info.irw.size(), info.irr.size() })
+    shape += " " + std::to_string(count);
+  for (const auto &cf : info.icf)
+    shape += " " + cf;
+
+  // Measure an anonymous scratch lift of the instruction, erasing it from the module
+
+  auto size = mSizes.find(shape);
+  if (size == mSizes.end()) {
+    auto *Function = mLifter.Lift(bytes);
+    mLifter.Materialize(Function);
+    size = mSizes.emplace(shape, Function->getInstructionCount()).first;
+    Function->eraseFromParent();
+  }
+
+  // Update the histogram
+
+  auto &entry = mEntries[{ ZydisMnemonicGetString(info.mnemonic), info.form }];
+  entry.irMin = entry.count ? std::min(entry.irMin, size->second) : size->second;
+  entry.irMax = std::max(entry.irMax, size->second);
+  entry.irTotal += size->second;
+  entry.count++;
+  entry.errw += info.errw.size();
+  entry.erw += info.erw.size();
+  entry.err += info.err.size();
+  entry.irrw += info.irrw.size();
+  entry.irw += info.irw.size();
+  entry.irr += info.irr.size();
+  for (const auto &cf : info.icf)
+    entry.clobbers[cf]++;
+  mCount++;
+
+  return true;
+}
+
+size_t UIProfiler::AddBuffer(const ZyanU8 *buffer, size_t size, size_t address, const UILifter::ScanFilter &filter) {
+  size_t count = 0;
+  for (const auto &candidate : mLifter.Scan(buffer, size, address, filter)) {
+    const auto *bytes = buffer + (candidate.address - address);
+    if (Add({ bytes, bytes + candidate.length }))
+      count++;
+  }
+  return count;
+}
+
+void UIProfiler::Write(llvm::raw_ostream &OS) const {
+
+  std::vector<std::pair<const std::pair<std::string, std::string> *, const Entry *>> entries;
+  for (const auto &it : mEntries)
+    entries.emplace_back(&it.first, &it.second);
+  std::stable_sort(entries.begin(), entries.end(), [](const auto &a, const auto &b) {
+    return a.second->count > b.second->count;
+  });
+
+  llvm::json::OStream J(OS, 2);
+  J.object([&] {
+    J.attribute("instructions", static_cast<int64_t>(mCount));
+    J.attributeArray("stubs", [&] {
+      for (const auto &it : entries) {
+        const auto &entry = *it.second;
+        J.object([&] {
+          J.attribute("mnemonic", it.first->first);
+          J.attribute("form", it.first->second);
+          J.attribute("count", static_cast<int64_t>(entry.count));
+          J.attributeObject("explicit", [&] {
+            J.attribute("readwrite", static_cast<int64_t>(entry.errw));
+            J.attribute("write", static_cast<int64_t>(entry.erw));
+            J.attribute("read", static_cast<int64_t>(entry.err));
+          });
+          J.attributeObject("implicit", [&] {
+            J.attribute("readwrite", static_cast<int64_t>(entry.irrw));
+            J.attribute("write", static_cast<int64_t>(entry.irw));
+            J.attribute("read", static_cast<int64_t>(entry.irr));
+          });
+          J.attributeObject("clobbers", [&] {
+            for (const auto &cf : entry.clobbers)
+              J.attribute(cf.first, static_cast<int64_t>(cf.second));
+          });
+          J.attributeObject("ir", [&] {
+            J.attribute("total", static_cast<int64_t>(entry.irTotal));
+            J.attribute("min", static_cast<int64_t>(entry.irMin));
+            J.attribute("max", static_cast<int64_t>(entry.irMax));
+          });
+        });
+      }
+    });
+  });
+  OS << "\n";
+}
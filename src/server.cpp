@@ -0,0 +1,413 @@
+#include <server.h>
+
+#include <llvm/Bitcode/BitcodeWriter.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <map>
+#include <thread>
+#include <vector>
+
+static bool setNonBlocking(int Descriptor) {
+  const int Flags = fcntl(Descriptor, F_GETFL, 0);
+  return Flags >= 0 && fcntl(Descriptor, F_SETFL, Flags | O_NONBLOCK) >= 0;
+}
+
+UIServer::UIServer(const std::string &Path, size_t Workers, bool Is64) : mPath(Path), mWorkers(Workers), mIs64(Is64) {
+  if (mWorkers == 0)
+    mWorkers = std::max<size_t>(1, std::thread::hardware_concurrency());
+  if (pipe(mWakeup) < 0 || !setNonBlocking(mWakeup[0]) || !setNonBlocking(mWakeup[1]))
+    llvm::report_fatal_error(std::string() + __func__ + ": failed to create the wakeup pipe!");
+}
+
+UIServer::~UIServer() {
+  close(mWakeup[0]);
+  close(mWakeup[1]);
+}
+
+void UIServer::Stop() {
+  mStopping = true;
+  const auto Written = write(mWakeup[1], "", 1);
+  (void)Written;
+}
+
+int UIServer::Run() {
+
+  // Bind the listening socket
+
+  sockaddr_un Address{};
+  Address.sun_family = AF_UNIX;
+  if (mPath.size() >= sizeof(Address.sun_path)) {
+    llvm::errs() << __func__ << ": the socket path is too long!\n";
+    return 1;
+  }
+  std::strncpy(Address.sun_path, mPath.c_str(), sizeof(Address.sun_path) - 1);
+
+  const int Listener = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (Listener < 0) {
+    llvm::errs() << __func__ << ": failed to create the socket: " << std::strerror(errno) << "\n";
+    return 1;
+  }
+
+  // Replace a stale socket, never a regular file
+
+  struct stat Existing;
+  if (lstat(mPath.c_str(), &Existing) == 0) {
+    if (!S_ISSOCK(Existing.st_mode)) {
+      llvm::errs() << __func__ << ": " << mPath << " already exists and isn't a socket!\n";
+      close(Listener);
+      return 1;
+    }
+    unlink(mPath.c_str());
+  }
+
+  if (bind(Listener, reinterpret_cast<sockaddr *>(&Address), sizeof(Address)) < 0) {
+    llvm::errs() << __func__ << ": failed to bind " << mPath << ": " << std::strerror(errno) << "\n";
+    close(Listener);
+    return 1;
+  }
+
+  // Remove the socket on exit only if it's still the one bound here
+
+  struct stat Bound;
+  const bool Owned = lstat(mPath.c_str(), &Bound) == 0;
+  auto removeSocket = [&]() {
+    struct stat Current;
+    if (Owned && lstat(mPath.c_str(), &Current) == 0 && Current.st_dev == Bound.st_dev && Current.st_ino == Bound.st_ino)
+      unlink(mPath.c_str());
+  };
+
+  if (listen(Listener, SOMAXCONN) < 0 || !setNonBlocking(Listener)) {
+    llvm::errs() << __func__ << ": failed to listen on " << mPath << ": " << std::strerror(errno) << "\n";
+    close(Listener);
+    removeSocket();
+    return 1;
+  }
+
+  // Start the workers, each one owning a warm lifter
+
+  std::vector<std::thread> Workers;
+  for (size_t i = 0; i < mWorkers; i++)
+    Workers.emplace_back(&UIServer::serveWorker, this);
+
+  // Multiplex the connections
+
+  std::map<int, Connection> Connections;
+  std::vector<pollfd> Polled;
+  int Result = 0;
+
+  while (!mStopping) {
+
+    // The full connections aren't read, the connections without events are left out of the poll:
+    // a closed peer reports POLLHUP on every call while its batch is served
+
+    Polled.clear();
+    Polled.push_back({ Listener, POLLIN, 0 });
+    Polled.push_back({ mWakeup[0], POLLIN, 0 });
+    for (const auto &it : Connections) {
+      short Events = 0;
+      if (!it.second.closed && !it.second.full())
+        Events |= POLLIN;
+      if (!it.second.output.empty())
+        Events |= POLLOUT;
+      Polled.push_back({ Events ? it.first : -1, Events, 0 });
+    }
+
+    if (poll(Polled.data(), Polled.size(), -1) < 0) {
+      if (errno == EINTR)
+        continue;
+      llvm::errs() << __func__ << ": failed to poll the connections: " << std::strerror(errno) << "\n";
+      Result = 1;
+      break;
+    }
+
+    // Accept the new clients
+
+    if (Polled[0].revents & POLLIN) {
+      for (;;) {
+        const int Socket = accept(Listener, nullptr, nullptr);
+        if (Socket < 0) {
+          if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR && errno != ECONNABORTED)
+            llvm::errs() << __func__ << ": failed to accept a client: " << std::strerror(errno) << "\n";
+          break;
+        }
+        if (!setNonBlocking(Socket)) {
+          close(Socket);
+          continue;
+        }
+        Connections[Socket];
+      }
+    }
+
+    // Collect the batches served by the workers
+
+    if (Polled[1].revents & POLLIN) {
+      char Drain[256];
+      while (read(mWakeup[0], Drain, sizeof(Drain)) > 0)
+        ;
+      std::deque<Batch> Served;
+      {
+        std::lock_guard<std::mutex> Lock(mMutex);
+        Served.swap(mServed);
+      }
+      for (auto &Done : Served) {
+        auto &Client = Connections[Done.socket];
+        Client.busy = false;
+        if (!Client.broken)
+          Client.output += Done.responses;
+      }
+    }
+
+    // Read the requests and write the responses of the ready clients
+
+    for (size_t i = 2; i < Polled.size(); i++) {
+      if (Polled[i].fd < 0)
+        continue;
+      auto &Client = Connections[Polled[i].fd];
+      if ((Polled[i].revents & (POLLIN | POLLHUP | POLLERR)) && !Client.closed && !Client.full())
+        readClient(Polled[i].fd, Client);
+      if (Polled[i].revents & POLLOUT)
+        writeClient(Polled[i].fd, Client);
+    }
+
+    // Dispatch the complete requests and close the finished clients
+
+    for (auto it = Connections.begin(); it != Connections.end();) {
+      auto &Client = it->second;
+      dispatchClient(it->first, Client);
+      if (!Client.busy && Client.closed && (Client.broken || Client.output.empty())) {
+        close(it->first);
+        it = Connections.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+
+  // Stop the workers once the pending batches are served
+
+  {
+    std::lock_guard<std::mutex> Lock(mMutex);
+    mStop = true;
+  }
+  mCondition.notify_all();
+  for (auto &Worker : Workers)
+    Worker.join();
+
+  for (const auto &it : Connections)
+    close(it.first);
+  close(Listener);
+  removeSocket();
+
+  return Result;
+}
+
+void UIServer::readClient(int Socket, Connection &Client) const {
+  ZyanU8 Buffer[0x10000];
+  while (!Client.full()) {
+    const auto Read = recv(Socket, Buffer, sizeof(Buffer), 0);
+    if (Read > 0) {
+      Client.input.insert(Client.input.end(), Buffer, Buffer + Read);
+      continue;
+    }
+    if (Read < 0 && errno == EINTR)
+      continue;
+    if (Read < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+      return;
+    // The client finished sending its requests or the connection failed
+    Client.closed = true;
+    Client.broken = Read < 0;
+    return;
+  }
+}
+
+void UIServer::writeClient(int Socket, Connection &Client) const {
+  size_t Sent = 0;
+  while (Sent < Client.output.size()) {
+    const auto Written = send(Socket, Client.output.data() + Sent, Client.output.size() - Sent, MSG_NOSIGNAL);
+    if (Written > 0) {
+      Sent += Written;
+      continue;
+    }
+    if (Written < 0 && errno == EINTR)
+      continue;
+    if (Written < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+      break;
+    Client.closed = true;
+    Client.broken = true;
+    Client.output.clear();
+    return;
+  }
+  Client.output.erase(0, Sent);
+}
+
+void UIServer::dispatchClient(int Socket, Connection &Client) {
+
+  // A single batch per connection is served at a time to keep the responses in order,
+  // and none while the responses already exceed the connection buffer
+
+  if (Client.busy || Client.broken || Client.output.size() >= MaxConnectionBuffer)
+    return;
+
+  size_t Offset = 0;
+  size_t Requests = 0;
+  while (Requests < MaxBatchRequests && Client.input.size() - Offset >= RequestHeaderSize) {
+    const size_t Size = RequestHeaderSize + Client.input[Offset + 9];
+    if (Client.input.size() - Offset < Size)
+      break;
+    Offset += Size;
+    Requests++;
+  }
+  if (Requests == 0)
+    return;
+
+  Batch Pending;
+  Pending.socket = Socket;
+  Pending.requests.assign(Client.input.begin(), Client.input.begin() + Offset);
+  Client.input.erase(Client.input.begin(), Client.input.begin() + Offset);
+  Client.busy = true;
+
+  {
+    std::lock_guard<std::mutex> Lock(mMutex);
+    mPending.push_back(std::move(Pending));
+  }
+  mCondition.notify_one();
+}
+
+void UIServer::serveWorker() {
+
+  // The LLVM context isn't thread safe, each worker keeps its own lifter and module
+
+  std::unique_ptr<llvm::LLVMContext> Context;
+  std::unique_ptr<llvm::Module> Module;
+  std::unique_ptr<UILifter> Lifter;
+  size_t Lifts = 0;
+
+  auto reset = [&]() {
+    Lifter.reset();
+    Module.reset();
+    Context = std::make_unique<llvm::LLVMContext>();
+    Module = std::make_unique<llvm::Module>("Module", *Context);
+    Lifter = UILifter::Create(*Module, mIs64);
+    Lifts = 0;
+  };
+
+  reset();
+
+  for (;;) {
+    Batch Current;
+    {
+      std::unique_lock<std::mutex> Lock(mMutex);
+      mCondition.wait(Lock, [this] { return mStop || !mPending.empty(); });
+      if (mPending.empty())
+        return;
+      Current = std::move(mPending.front());
+      mPending.pop_front();
+    }
+
+    // Serve the requests, the batch only holds complete requests
+
+    size_t Offset = 0;
+    while (Offset < Current.requests.size()) {
+      if (serveRequest(Current.requests.data() + Offset, *Lifter, *Module, Current.responses) && ++Lifts == MaxWorkerLifts)
+        reset();
+      Offset += RequestHeaderSize + Current.requests[Offset + 9];
+    }
+
+    {
+      std::lock_guard<std::mutex> Lock(mMutex);
+      mServed.push_back(std::move(Current));
+    }
+    // A full pipe already wakes up the connections thread
+    const auto Written = write(mWakeup[1], "", 1);
+    (void)Written;
+  }
+}
+
+bool UIServer::serveRequest(const ZyanU8 *Request, UILifter &Lifter, llvm::Module &Module, std::string &Response) {
+
+  auto appendResponse = [&Response](Status Result, const std::string &Payload) {
+    Response.push_back(static_cast<char>(Result));
+    for (size_t i = 0; i < 4; i++)
+      Response.push_back(static_cast<char>((Payload.size() >> (i * 8)) & 0xFF));
+    Response += Payload;
+  };
+
+  // Parse the request
+
+  const auto RequestFormat = Request[0];
+  uint64_t Address = 0;
+  for (size_t i = 0; i < 8; i++)
+    Address |= static_cast<uint64_t>(Request[1 + i]) << (i * 8);
+  const std::vector<ZyanU8> Bytes(Request + RequestHeaderSize, Request + RequestHeaderSize + Request[9]);
+
+  if (RequestFormat != FORMAT_BITCODE && RequestFormat != FORMAT_TEXT) {
+    appendResponse(STATUS_FAILURE, "unknown format");
+    return false;
+  }
+
+  if (Bytes.empty() || Bytes.size() > ZYDIS_MAX_INSTRUCTION_LENGTH || !Lifter.CanLift(Bytes)) {
+    appendResponse(STATUS_FAILURE, "failed to disassemble the bytes");
+    return false;
+  }
+
+  // Reuse the response to an identical request
+
+  const std::string Key(reinterpret_cast<const char *>(Request), RequestHeaderSize + Bytes.size());
+  std::string Cached;
+  if (findResponse(Key, Cached)) {
+    Response += Cached;
+    return false;
+  }
+
+  // Lift the instruction in the worker module, which holds only this function, and erase it once serialized
+
+  auto *Function = Lifter.Lift(Bytes, Address);
+
+  std::string Payload;
+  llvm::raw_string_ostream Stream(Payload);
+  if (RequestFormat == FORMAT_BITCODE)
+    llvm::WriteBitcodeToFile(Module, Stream);
+  else
+    Module.print(Stream, nullptr);
+  Stream.flush();
+
+  Function->eraseFromParent();
+
+  const size_t Begin = Response.size();
+  appendResponse(STATUS_SUCCESS, Payload);
+  storeResponse(Key, Response.substr(Begin));
+
+  return true;
+}
+
+bool UIServer::findResponse(const std::string &Key, std::string &Response) {
+  std::lock_guard<std::mutex> Lock(mCacheMutex);
+  auto it = mCacheIndex.find(Key);
+  if (it == mCacheIndex.end())
+    return false;
+  mCache.splice(mCache.begin(), mCache, it->second);
+  Response = it->second->second;
+  return true;
+}
+
+void UIServer::storeResponse(const std::string &Key, const std::string &Response) {
+  std::lock_guard<std::mutex> Lock(mCacheMutex);
+  if (mCacheIndex.count(Key))
+    return;
+  mCache.emplace_front(Key, Response);
+  mCacheIndex[Key] = mCache.begin();
+  if (mCache.size() > MaxCachedResponses) {
+    mCacheIndex.erase(mCache.back().first);
+    mCache.pop_back();
+  }
+}
@@ -0,0 +1,64 @@
+#include <main.h>
+
+#include <llvm/Support/raw_ostream.h>
+
+// Check the deduplication, the replacement and the deletion of the functions in the address index
+
+static bool check(bool Condition, const char *Message) {
+  if (!Condition)
+    llvm::errs() << "index: " << Message << "!\n";
+  return Condition;
+}
+
+int main() {
+
+  llvm::LLVMContext Context;
+  llvm::Module Module("Module", Context);
+
+  const auto Lifter = UILifter::Create(Module);
+
+  const std::vector<ZyanU8> Cpuid{ 0x0F, 0xA2 };
+  const std::vector<ZyanU8> Rdtsc{ 0x0F, 0x31 };
+  const std::vector<ZyanU8> Add{ 0x01, 0xD8 };
+
+  bool Success = true;
+
+  // The same encoding at the same address is lifted once, the anonymous lifts aren't indexed
+
+  auto *First = Lifter->Lift(Cpuid, 0x1000);
+  Success &= check(Lifter->Lift(Cpuid, 0x1000) == First, "the same encoding has been lifted twice");
+  Success &= check(Lifter->Lift(Cpuid) != Lifter->Lift(Cpuid), "the anonymous lifts have been deduplicated");
+  Success &= check(Lifter->Lookup(0) == nullptr, "the anonymous lifts have been indexed");
+
+  // The interval lookups are bounded by [begin, end)
+
+  Lifter->Lift(Rdtsc, 0x1010);
+  Lifter->Lift(Add, 0x1020);
+  Success &= check(Lifter->Lookup(0x1000, 0x1020).size() == 2, "the interval includes its end");
+  Success &= check(Lifter->Lookup(0x1000, 0x1021).size() == 3, "the interval misses its last entry");
+  Success &= check(Lifter->Lookup(0x1001, 0x1010).empty(), "the interval includes the entries out of its bounds");
+  Success &= check(Lifter->Lookup(0x1020, 0x1020).empty(), "the empty interval has entries");
+  Success &= check(Lifter->Lookup(0x1000, 0x1021).front().address == 0x1000, "the interval isn't sorted");
+
+  // A different encoding at an indexed address replaces the entry and takes over the symbol name
+
+  UILifter::InstructionInfo Info;
+  Lifter->Classify(Add, Info);
+  const auto Name = Lifter->GetSymbolName(Info.mnemonic, 0x1000);
+
+  auto *Replacement = Lifter->Lift(Add, 0x1000);
+  const auto *Entry = Lifter->Lookup(0x1000);
+  Success &= check(Replacement != First, "the different encoding has been deduplicated");
+  Success &= check(Entry && Entry->function == Replacement, "the entry hasn't been replaced");
+  Success &= check(Replacement->getName() == Name, "the replacement doesn't have the stable name");
+  Success &= check(!First->hasName() && First->getParent() == &Module, "the replaced function isn't kept unnamed");
+
+  // Erasing a function removes its entry
+
+  Replacement->eraseFromParent();
+  Success &= check(Lifter->Lookup(0x1000) == nullptr, "the erased function is still indexed");
+  Success &= check(Lifter->Lookup(0x1000, 0x2000).size() == 2, "the erased function is still in the interval");
+  Success &= check(Lifter->Lift(Add, 0x1000)->getName() == Name, "the new lift doesn't have the stable name");
+
+  return Success ? 0 : 1;
+}
@@ -0,0 +1,46 @@
+#include <main.h>
+
+#include <llvm/IR/Verifier.h>
+#include <llvm/Support/raw_ostream.h>
+
+// Check that the lazy lifts are materialized through the module and that the deleted stubs are forgotten
+
+static bool check(bool Condition, const char *Message) {
+  if (!Condition)
+    llvm::errs() << "lazy: " << Message << "!\n";
+  return Condition;
+}
+
+int main() {
+
+  llvm::LLVMContext Context;
+  llvm::Module Module("Module", Context);
+
+  const auto Lifter = UILifter::Create(Module, true, false, true);
+
+  bool Success = true;
+
+  // The lazy lift only generates a materializable declaration
+
+  auto *Cpuid = Lifter->Lift({ 0x0F, 0xA2 }, 0x1000);
+  Success &= check(Cpuid->isMaterializable() && Cpuid->empty(), "the lazy lift has a body");
+
+  // Erasing a pending stub drops its recorded bytes, materializing the module must skip it
+
+  auto *Erased = Lifter->Lift({ 0x01, 0xD8 }, 0x1010);
+  Erased->eraseFromParent();
+
+  Success &= check(!Module.materializeAll(), "failed to materialize the module");
+  Success &= check(!Cpuid->isMaterializable() && !Cpuid->empty(), "the materialized lift has no body");
+
+  // The materializer is released by Module::materializeAll, a new one must be installed
+
+  auto *Rdtsc = Lifter->Lift({ 0x0F, 0x31 }, 0x1020);
+  Success &= check(Rdtsc->isMaterializable() && Rdtsc->empty(), "the second lazy lift has a body");
+  Success &= check(!Rdtsc->materialize(), "failed to materialize the function");
+  Success &= check(!Rdtsc->empty(), "the materialized function has no body");
+
+  Success &= check(!llvm::verifyModule(Module, &llvm::errs()), "the module is invalid");
+
+  return Success ? 0 : 1;
+}
@@ -0,0 +1,47 @@
+#include <main.h>
+
+#include <llvm/Support/raw_ostream.h>
+
+// Check that the parallel scan resynchronizes the chunks like a single threaded sweep
+
+static bool checkScan(const UILifter &Lifter, const std::vector<ZyanU8> &Buffer, const UILifter::ScanFilter &Filter, size_t Threads) {
+  const auto Expected = Lifter.Scan(Buffer.data(), Buffer.size(), 0x140001000, Filter, 1);
+  const auto Scanned = Lifter.Scan(Buffer.data(), Buffer.size(), 0x140001000, Filter, Threads);
+  bool Success = Expected.size() == Scanned.size();
+  for (size_t i = 0; Success && i < Expected.size(); i++) {
+    Success = Expected[i].address == Scanned[i].address &&
+      Expected[i].length == Scanned[i].length &&
+      Expected[i].mnemonic == Scanned[i].mnemonic;
+  }
+  if (!Success)
+    llvm::errs() << __func__ << ": the scan with " << Threads << " threads differs from the sequential sweep!\n";
+  return Success;
+}
+
+int main() {
+
+  llvm::LLVMContext Context;
+  llvm::Module Module("Module", Context);
+
+  const auto Lifter = UILifter::Create(Module);
+
+  // Generate a 256KB buffer of pseudo-random bytes, misaligning the instructions at the chunk boundaries
+
+  std::vector<ZyanU8> Buffer(0x40000);
+  uint32_t Seed = 0x12345678;
+  for (auto &Byte : Buffer) {
+    Seed = Seed * 1664525 + 1013904223;
+    Byte = static_cast<ZyanU8>(Seed >> 24);
+  }
+
+  const UILifter::ScanFilter All = [](const ZydisDecodedInstruction &) { return true; };
+  const UILifter::ScanFilter Some = [](const ZydisDecodedInstruction &instruction) { return instruction.length > 4; };
+
+  bool Success = true;
+  for (const size_t Threads : { 2, 3, 4 }) {
+    Success &= checkScan(*Lifter, Buffer, All, Threads);
+    Success &= checkScan(*Lifter, Buffer, Some, Threads);
+  }
+
+  return Success ? 0 : 1;
+}
@@ -0,0 +1,134 @@
+#include <server.h>
+
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+
+// Check the requests framing of the server over a real connection: an unknown format, an empty
+// instruction and a request split across two writes must be answered in order
+
+static bool check(bool Condition, const char *Message) {
+  if (!Condition)
+    llvm::errs() << "server: " << Message << "!\n";
+  return Condition;
+}
+
+static std::string getRequest(ZyanU8 Format, uint64_t Address, const std::vector<ZyanU8> &Bytes) {
+  std::string Request(1, static_cast<char>(Format));
+  for (size_t i = 0; i < 8; i++)
+    Request.push_back(static_cast<char>((Address >> (i * 8)) & 0xFF));
+  Request.push_back(static_cast<char>(Bytes.size()));
+  Request.append(Bytes.begin(), Bytes.end());
+  return Request;
+}
+
+static bool sendAll(int Socket, const std::string &Data) {
+  size_t Sent = 0;
+  while (Sent < Data.size()) {
+    const auto Written = send(Socket, Data.data() + Sent, Data.size() - Sent, MSG_NOSIGNAL);
+    if (Written <= 0)
+      return false;
+    Sent += Written;
+  }
+  return true;
+}
+
+static bool receiveAll(int Socket, std::string &Data, size_t Size) {
+  Data.resize(Size);
+  size_t Received = 0;
+  while (Received < Size) {
+    const auto Read = recv(Socket, &Data[Received], Size - Received, 0);
+    if (Read <= 0)
+      return false;
+    Received += Read;
+  }
+  return true;
+}
+
+static bool receiveResponse(int Socket, ZyanU8 &Status, std::string &Payload) {
+  std::string Header;
+  if (!receiveAll(Socket, Header, UIServer::ResponseHeaderSize))
+    return false;
+  Status = static_cast<ZyanU8>(Header[0]);
+  size_t Size = 0;
+  for (size_t i = 0; i < 4; i++)
+    Size |= static_cast<size_t>(static_cast<ZyanU8>(Header[1 + i])) << (i * 8);
+  return receiveAll(Socket, Payload, Size);
+}
+
+int main() {
+
+  llvm::SmallString<128> Path;
+  llvm::sys::fs::createUniquePath("uil-%%%%%%.sock", Path, true);
+
+  bool Success = true;
+
+  // An existing regular file is never replaced by the socket
+
+  {
+    std::FILE *File = std::fopen(Path.c_str(), "w");
+    std::fclose(File);
+    UIServer Server(Path.str().str(), 1);
+    Success &= check(Server.Run() != 0, "the server replaced a regular file");
+    Success &= check(llvm::sys::fs::is_regular_file(Path), "the regular file has been removed");
+    llvm::sys::fs::remove(Path);
+  }
+
+  // Serve a single client
+
+  UIServer Server(Path.str().str(), 1);
+  int Result = -1;
+  std::thread Thread([&] { Result = Server.Run(); });
+
+  sockaddr_un Address{};
+  Address.sun_family = AF_UNIX;
+  std::strncpy(Address.sun_path, Path.c_str(), sizeof(Address.sun_path) - 1);
+
+  const int Socket = socket(AF_UNIX, SOCK_STREAM, 0);
+  bool Connected = false;
+  for (size_t i = 0; i < 100 && !Connected; i++) {
+    Connected = connect(Socket, reinterpret_cast<sockaddr *>(&Address), sizeof(Address)) == 0;
+    if (!Connected)
+      std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  }
+  Success &= check(Connected, "failed to connect to the server");
+
+  timeval Timeout{ 10, 0 };
+  setsockopt(Socket, SOL_SOCKET, SO_RCVTIMEO, &Timeout, sizeof(Timeout));
+
+  // The split request is only served once complete, after the failures
+
+  const auto Split = getRequest(UIServer::FORMAT_TEXT, 0x1000, { 0x0F, 0xA2 });
+  Success &= check(sendAll(Socket, getRequest(0x7F, 0x1000, { 0x0F, 0xA2 })), "failed to send the unknown format");
+  Success &= check(sendAll(Socket, getRequest(UIServer::FORMAT_TEXT, 0x1000, {})), "failed to send the empty instruction");
+  Success &= check(sendAll(Socket, Split.substr(0, 5)), "failed to send the split request head");
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  Success &= check(sendAll(Socket, Split.substr(5)), "failed to send the split request tail");
+
+  ZyanU8 Status = 0;
+  std::string Payload;
+  Success &= check(receiveResponse(Socket, Status, Payload) && Status == UIServer::STATUS_FAILURE, "the unknown format has been served");
+  Success &= check(receiveResponse(Socket, Status, Payload) && Status == UIServer::STATUS_FAILURE, "the empty instruction has been served");
+  Success &= check(receiveResponse(Socket, Status, Payload) && Status == UIServer::STATUS_SUCCESS, "the split request hasn't been served");
+  Success &= check(Payload.find("_1000(") != std::string::npos, "the lifted function isn't named after its address");
+
+  close(Socket);
+
+  // The server removes its own socket once stopped
+
+  Server.Stop();
+  Thread.join();
+  Success &= check(Result == 0, "the server failed");
+  Success &= check(!llvm::sys::fs::exists(Path), "the socket hasn't been removed");
+
+  return Success ? 0 : 1;
+}